@@ -0,0 +1,76 @@
+// Microbenchmarks for the JSON and URL helpers in go_webkit.h. Prints one JSON
+// object per line. Build and run it with `make bench-cc`.
+
+#include "go_webkit.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+volatile size_t sink;
+
+// Runs fn in growing batches until a batch takes at least 200ms, then prints
+// the per-iteration time and throughput for bytes processed per iteration.
+template <typename F> void bench(const char *name, size_t bytes, F fn) {
+  for (long n = 1;; n *= 2) {
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < n; i++) {
+      sink = sink + fn();
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+    if (ns >= 200000000) {
+      double per_op = (double)ns / (double)n;
+      printf("{\"name\":\"%s\",\"n\":%ld,\"ns_per_op\":%.2f,\"bytes\":%zu,"
+             "\"mb_per_sec\":%.2f}\n",
+             name, n, per_op, bytes, (double)bytes / per_op * 1e3);
+      return;
+    }
+  }
+}
+
+} // namespace
+
+int main() {
+  const std::string msg =
+      "{\"id\":42,\"method\":\"update\",\"params\":[\"hello \\\"world\\\"\","
+      "{\"x\":1,\"y\":[1,2,3]},3.14159,true,null]}";
+  std::string html = "<html><body>";
+  while (html.size() < 4096) {
+    html += "<p class=\"row\">Hello, world! 100% & more</p>";
+  }
+  html += "</body></html>";
+  const std::string params = go_webkit::json_parse(msg, "params", 0);
+  const std::string encoded = go_webkit::url_encode(html);
+  const std::string uri = "data:text/html," + encoded;
+
+  bench("json_parse_c/key", msg.size(), [&]() {
+    const char *value;
+    size_t sz;
+    go_webkit::json_parse_c(msg.c_str(), msg.size(), "params", 6, &value, &sz);
+    return sz;
+  });
+  bench("json_parse_c/array_index", params.size(), [&]() {
+    const char *value;
+    size_t sz;
+    go_webkit::json_parse_c(params.c_str(), params.size(), nullptr, 2, &value,
+                            &sz);
+    return sz;
+  });
+  bench("json_parse/key", msg.size(),
+        [&]() { return go_webkit::json_parse(msg, "method", 0).size(); });
+  bench("json_parse/string", msg.size(), [&]() {
+    return go_webkit::json_parse(go_webkit::json_parse(msg, "params", 0), "", 0)
+        .size();
+  });
+  bench("url_encode", html.size(),
+        [&]() { return go_webkit::url_encode(html).size(); });
+  bench("url_decode", encoded.size(),
+        [&]() { return go_webkit::url_decode(encoded).size(); });
+  bench("html_from_uri", uri.size(),
+        [&]() { return go_webkit::html_from_uri(uri).size(); });
+  return 0;
+}
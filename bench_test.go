@@ -0,0 +1,137 @@
+package webkit
+
+// Benchmarks for the Go side of the bridge. Those that drive a real window
+// only run when -bench is given and a display is available, on a headless
+// machine run them with `make bench-go`, which uses Xvfb.
+
+import (
+	"flag"
+	"fmt"
+	"net/url"
+	"os"
+	"sort"
+	"testing"
+	"time"
+)
+
+const benchPage = `<html><body><script>
+window.onload = function() { ready(); };
+</script></body></html>`
+
+var (
+	bench     Webkit
+	benchPong = make(chan struct{}, 1)
+)
+
+func TestMain(tm *testing.M) {
+	flag.Parse()
+	display := os.Getenv("DISPLAY") != "" || os.Getenv("WAYLAND_DISPLAY") != ""
+	if flag.Lookup("test.bench").Value.String() == "" || !display {
+		os.Exit(tm.Run())
+	}
+
+	w := New(false)
+	ready := make(chan struct{}, 1)
+	for name, f := range map[string]interface{}{
+		"ready": func() { ready <- struct{}{} },
+		"pong":  func() { benchPong <- struct{}{} },
+		"echo":  func(i int) int { return i },
+	} {
+		if err := w.Bind(name, f); err != nil {
+			panic(err)
+		}
+	}
+	w.Navigate("data:text/html," + url.QueryEscape(benchPage))
+	bench = w
+
+	code := make(chan int, 1)
+	go func() {
+		select {
+		case <-ready:
+			code <- tm.Run()
+		case <-time.After(30 * time.Second):
+			fmt.Fprintln(os.Stderr, "timed out waiting for the benchmark page to load")
+			code <- 1
+		}
+		w.Dispatch(w.Terminate)
+	}()
+	w.Run()
+	w.Destroy()
+	os.Exit(<-code)
+}
+
+func window(b *testing.B) Webkit {
+	if bench == nil {
+		b.Skip("needs a display")
+	}
+	return bench
+}
+
+// roundTrip times b.N calls of f, each of which must return once its round
+// trip completes, and adds p50 and p99 to the output.
+func roundTrip(b *testing.B, f func()) {
+	lat := make([]time.Duration, b.N)
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		t := time.Now()
+		f()
+		lat[i] = time.Since(t)
+	}
+	b.StopTimer()
+	sort.Slice(lat, func(i, j int) bool { return lat[i] < lat[j] })
+	b.ReportMetric(float64(lat[len(lat)*50/100].Nanoseconds()), "p50-ns")
+	b.ReportMetric(float64(lat[len(lat)*99/100].Nanoseconds()), "p99-ns")
+}
+
+func BenchmarkDispatch(b *testing.B) {
+	w := window(b)
+	roundTrip(b, func() {
+		ch := make(chan struct{})
+		w.Dispatch(func() { close(ch) })
+		<-ch
+	})
+}
+
+func BenchmarkEval(b *testing.B) {
+	w := window(b)
+	roundTrip(b, func() {
+		w.Dispatch(func() { w.Eval("pong()") })
+		<-benchPong
+	})
+}
+
+// BenchmarkBind measures a full RPC: JavaScript calls a bound Go function and
+// waits for its promise to resolve.
+func BenchmarkBind(b *testing.B) {
+	w := window(b)
+	roundTrip(b, func() {
+		w.Dispatch(func() { w.Eval("echo(1).then(function() { pong(); })") })
+		<-benchPong
+	})
+}
+
+// BenchmarkBindingCall measures argument decoding and the reflective call of
+// a bound function, without the trip through WebKit.
+func BenchmarkBindingCall(b *testing.B) {
+	binding, err := makeBinding(func(i int) int { return i })
+	if err != nil {
+		b.Fatal(err)
+	}
+	b.ReportAllocs()
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if _, err := binding("1", "[1]"); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
+
+func BenchmarkStats(b *testing.B) {
+	w := window(b)
+	b.ReportAllocs()
+	for i := 0; i < b.N; i++ {
+		if _, err := w.Stats(); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
@@ -0,0 +1,131 @@
+package main
+
+// Benchmarks what testing.B can't express: many RPCs in flight at once,
+// navigating to a large page, and the bridge stats after a run. Prints one JSON
+// object per line. Round trips of single calls are measured by the benchmarks
+// in bench_test.go. It needs a display, `make bench-e2e` runs it under Xvfb.
+
+import (
+	"encoding/json"
+	"flag"
+	"fmt"
+	"net/url"
+	"os"
+	"sort"
+	"strings"
+	"time"
+
+	"github.com/nathants/go-webkit"
+)
+
+const page = `<html><body><script>
+async function rpcParallel(n) {
+  var calls = [];
+  for (var i = 0; i < n; i++) {
+    calls.push(echo(i));
+  }
+  await Promise.all(calls);
+  done();
+}
+window.onload = function() { ready(); };
+</script><!--PADDING--></body></html>`
+
+type result struct {
+	Name      string  `json:"name"`
+	N         int     `json:"n"`
+	NsPerOp   float64 `json:"ns_per_op"`
+	OpsPerSec float64 `json:"ops_per_sec"`
+	P50Ns     *int64  `json:"p50_ns,omitempty"`
+	P99Ns     *int64  `json:"p99_ns,omitempty"`
+}
+
+func printJSON(v interface{}) {
+	b, err := json.Marshal(v)
+	if err != nil {
+		panic(err)
+	}
+	fmt.Println(string(b))
+}
+
+func report(name string, total time.Duration, lat []time.Duration, n int) {
+	r := result{
+		Name:      name,
+		N:         n,
+		NsPerOp:   float64(total.Nanoseconds()) / float64(n),
+		OpsPerSec: float64(n) / total.Seconds(),
+	}
+	if len(lat) > 0 {
+		sort.Slice(lat, func(i, j int) bool { return lat[i] < lat[j] })
+		p50 := lat[len(lat)*50/100].Nanoseconds()
+		p99 := lat[len(lat)*99/100].Nanoseconds()
+		r.P50Ns, r.P99Ns = &p50, &p99
+	}
+	printJSON(r)
+}
+
+func main() {
+	n := flag.Int("n", 10000, "calls in flight in the rpc_parallel benchmark")
+	size := flag.Int("size", 1<<20, "padding in bytes of the page used by the navigate benchmark")
+	flag.Parse()
+	if *n <= 0 || *size < 0 {
+		fmt.Fprintln(os.Stderr, "-n must be positive and -size must not be negative")
+		os.Exit(2)
+	}
+
+	w := webkit.New(false)
+	defer w.Destroy()
+	w.SetTitle("go-webkit bench")
+	w.SetSize(800, 600, webkit.HintNone)
+
+	ready := make(chan struct{}, 1)
+	done := make(chan struct{}, 1)
+	for name, f := range map[string]interface{}{
+		"ready": func() { ready <- struct{}{} },
+		"done":  func() { done <- struct{}{} },
+		"echo":  func(i int) int { return i },
+	} {
+		if err := w.Bind(name, f); err != nil {
+			panic(err)
+		}
+	}
+	eval := func(js string) { w.Dispatch(func() { w.Eval(js) }) }
+	navigate := func(padding int) {
+		html := strings.Replace(page, "<!--PADDING-->", "<!--"+strings.Repeat("x", padding)+"-->", 1)
+		w.Dispatch(func() { w.Navigate("data:text/html," + url.QueryEscape(html)) })
+	}
+
+	go func() {
+		navigate(0)
+		<-ready
+
+		// JavaScript -> binding -> resolve -> JavaScript, all calls in flight
+		start := time.Now()
+		eval(fmt.Sprintf("rpcParallel(%d)", *n))
+		<-done
+		report("rpc_parallel", time.Since(start), nil, *n)
+
+		// Navigate to a large data URI and wait for window.onload
+		iterations := 10
+		lat := make([]time.Duration, iterations)
+		start = time.Now()
+		for i := 0; i < iterations; i++ {
+			t := time.Now()
+			navigate(*size)
+			<-ready
+			lat[i] = time.Since(t)
+		}
+		report("navigate", time.Since(start), lat, iterations)
+
+		stats, err := w.Stats()
+		if err != nil {
+			panic(err)
+		}
+		printJSON(struct {
+			Name  string       `json:"name"`
+			Stats webkit.Stats `json:"stats"`
+		}{"bridge_stats", stats})
+		w.Dispatch(w.Terminate)
+	}()
+
+	w.Run()
+}
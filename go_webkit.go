@@ -120,6 +120,17 @@ type Webkit interface {
 	// f must be a function
 	// f must return either value and error or just error
 	Bind(name string, f interface{}) error
+
+	// Stats returns a snapshot of the bridge counters and latency histograms.
+	// It is safe to call this function from a background thread.
+	Stats() (Stats, error)
+
+	// Trace starts or stops recording trace events. Only the most recent
+	// events are kept.
+	Trace(enabled bool)
+
+	// TraceJSON returns the recorded trace events in Chrome trace JSON format.
+	TraceJSON() []byte
 }
 
 type goWebkit struct {
@@ -240,18 +251,20 @@ func _goWebkitBindingGoCallback(w C.go_webkit_t, id *C.char, req *C.char, index
 	C.go_webkit_return(w, id, C.int(status), s)
 }
 
-func (w *goWebkit) Bind(name string, f interface{}) error {
+// makeBinding wraps f so that it can be called with the JSON array of
+// arguments sent by JavaScript.
+func makeBinding(f interface{}) (func(id, req string) (interface{}, error), error) {
 	v := reflect.ValueOf(f)
 	// f must be a function
 	if v.Kind() != reflect.Func {
-		return errors.New("only functions can be bound")
+		return nil, errors.New("only functions can be bound")
 	}
 	// f must return either value and error or just error
 	if n := v.Type().NumOut(); n > 2 {
-		return errors.New("function may only return a value or a value+error")
+		return nil, errors.New("function may only return a value or a value+error")
 	}
 
-	binding := func(id, req string) (interface{}, error) {
+	return func(id, req string) (interface{}, error) {
 		raw := []json.RawMessage{}
 		if err := json.Unmarshal([]byte(req), &raw); err != nil {
 			return nil, err
@@ -302,6 +315,13 @@ func (w *goWebkit) Bind(name string, f interface{}) error {
 		default:
 			return nil, errors.New("unexpected number of return values")
 		}
+	}, nil
+}
+
+func (w *goWebkit) Bind(name string, f interface{}) error {
+	binding, err := makeBinding(f)
+	if err != nil {
+		return err
 	}
 
 	m.Lock()
@@ -314,3 +334,21 @@ func (w *goWebkit) Bind(name string, f interface{}) error {
 	C.CgoWebkitBind(w.w, cname, C.uintptr_t(index))
 	return nil
 }
+
+func (w *goWebkit) Stats() (Stats, error) {
+	s := C.go_webkit_stats(w.w)
+	defer C.free(unsafe.Pointer(s))
+	stats := Stats{}
+	err := json.Unmarshal([]byte(C.GoString(s)), &stats)
+	return stats, err
+}
+
+func (w *goWebkit) Trace(enabled bool) {
+	C.go_webkit_trace(w.w, boolToInt(enabled))
+}
+
+func (w *goWebkit) TraceJSON() []byte {
+	s := C.go_webkit_trace_json(w.w)
+	defer C.free(unsafe.Pointer(s))
+	return []byte(C.GoString(s))
+}
@@ -100,6 +100,23 @@ GO_WEBKIT_API void go_webkit_bind(go_webkit_t w, const char *name, void (*fn)(co
 // If status is not zero - result is an error JSON object.
 GO_WEBKIT_API void go_webkit_return(go_webkit_t w, const char *seq, int status, const char *result);
 
+// Returns a JSON snapshot of the bridge counters and latency histograms. The
+// string is allocated with malloc() and must be released with free(). If the
+// library was compiled with GO_WEBKIT_NO_STATS the snapshot only contains
+// {"enabled":false}.
+GO_WEBKIT_API char *go_webkit_stats(go_webkit_t w);
+
+// Starts (if enable is non-zero) or stops recording trace events for message
+// handling, dispatch, eval, navigation and RPC round trips. Recording keeps
+// only the most recent events. It is safe to call this function from a
+// background thread.
+GO_WEBKIT_API void go_webkit_trace(go_webkit_t w, int enable);
+
+// Returns the recorded trace events in Chrome trace JSON format, which can be
+// loaded into chrome://tracing or Perfetto. The string is allocated with
+// malloc() and must be released with free().
+GO_WEBKIT_API char *go_webkit_trace_json(go_webkit_t w);
+
 #ifdef __cplusplus
 }
 #endif
@@ -107,13 +124,20 @@ GO_WEBKIT_API void go_webkit_return(go_webkit_t w, const char *seq, int status,
 #ifndef GO_WEBKIT_HEADER
 
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <future>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
 namespace go_webkit {
@@ -318,9 +342,43 @@ inline int json_parse_c(const char *s, size_t sz, const char *key, size_t keysz,
   return -1;
 }
 
-inline std::string json_escape(std::string s) {
-  // TODO: implement
-  return '"' + s + '"';
+inline std::string json_escape(const std::string &s) {
+  std::string escaped = "\"";
+  for (unsigned int i = 0; i < s.length(); i++) {
+    unsigned char c = s[i];
+    switch (c) {
+    case '"':
+      escaped += "\\\"";
+      break;
+    case '\\':
+      escaped += "\\\\";
+      break;
+    case '\b':
+      escaped += "\\b";
+      break;
+    case '\f':
+      escaped += "\\f";
+      break;
+    case '\n':
+      escaped += "\\n";
+      break;
+    case '\r':
+      escaped += "\\r";
+      break;
+    case '\t':
+      escaped += "\\t";
+      break;
+    default:
+      if (c < 32) {
+        char hex[7];
+        snprintf(hex, sizeof(hex), "\\u%04x", c);
+        escaped += hex;
+      } else {
+        escaped.push_back(c);
+      }
+    }
+  }
+  return escaped + '"';
 }
 
 inline int json_unescape(const char *s, size_t n, char *out) {
@@ -404,6 +462,344 @@ inline std::string json_parse(const std::string s, const std::string key,
   return "";
 }
 
+using stats_clock = std::chrono::steady_clock;
+
+inline uint64_t elapsed_ns(stats_clock::time_point start,
+                           stats_clock::time_point end) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+      .count();
+}
+
+#ifndef GO_WEBKIT_NO_STATS
+
+// Log-linear latency histogram in the spirit of HdrHistogram. Every power of
+// two is split into four sub-buckets, which bounds the relative error of a
+// reported percentile to 25% over the whole 64-bit nanosecond range while
+// keeping record() a single relaxed increment.
+class histogram {
+public:
+  static const int sub_bits = 2;
+  static const int sub_count = 1 << sub_bits;
+  static const int bucket_count = (64 - sub_bits + 1) * sub_count;
+
+  histogram() {
+    for (int i = 0; i < bucket_count; i++) {
+      m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  static int index(uint64_t v) {
+    if (v < sub_count) {
+      return (int)v;
+    }
+    int msb = 63 - __builtin_clzll(v);
+    int sub = (int)((v >> (msb - sub_bits)) & (sub_count - 1));
+    return (msb - sub_bits + 1) * sub_count + sub;
+  }
+
+  // Largest value that falls into the bucket i.
+  static uint64_t upper_bound(int i) {
+    if (i < sub_count) {
+      return (uint64_t)i;
+    }
+    int shift = i / sub_count - 1;
+    uint64_t sub = (uint64_t)(sub_count + i % sub_count);
+    return (sub << shift) + ((uint64_t)1 << shift) - 1;
+  }
+
+  void record(uint64_t v) {
+    m_buckets[index(v)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(v, std::memory_order_relaxed);
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (v > max && !m_max.compare_exchange_weak(max, v,
+                                                   std::memory_order_relaxed)) {
+    }
+  }
+
+  std::string to_json() const {
+    uint64_t counts[bucket_count];
+    uint64_t total = 0;
+    for (int i = 0; i < bucket_count; i++) {
+      counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+      total += counts[i];
+    }
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    auto percentile = [&](double q) -> uint64_t {
+      if (total == 0) {
+        return 0;
+      }
+      uint64_t rank = (uint64_t)(q * (double)total + 0.999999);
+      if (rank == 0) {
+        rank = 1;
+      }
+      uint64_t seen = 0;
+      for (int i = 0; i < bucket_count; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+          uint64_t v = upper_bound(i);
+          return v < max ? v : max;
+        }
+      }
+      return max;
+    };
+    return "{\"count\":" + std::to_string(total) +
+           ",\"sum_ns\":" + std::to_string(m_sum.load()) +
+           ",\"max_ns\":" + std::to_string(max) +
+           ",\"p50_ns\":" + std::to_string(percentile(0.5)) +
+           ",\"p90_ns\":" + std::to_string(percentile(0.9)) +
+           ",\"p99_ns\":" + std::to_string(percentile(0.99)) +
+           ",\"p999_ns\":" + std::to_string(percentile(0.999)) + "}";
+  }
+
+private:
+  std::atomic<uint64_t> m_buckets[bucket_count];
+  std::atomic<uint64_t> m_sum{0};
+  std::atomic<uint64_t> m_max{0};
+};
+
+// Bridge instrumentation. Almost every hook runs on the UI thread; dispatch,
+// eval and resolve may also be called from background threads, so counters
+// are relaxed atomics and only the RPC bookkeeping takes a lock.
+class stats {
+public:
+  stats() : m_epoch(stats_clock::now()) {}
+
+  static stats_clock::time_point now() { return stats_clock::now(); }
+
+  void bind(const std::string &name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_bindings.find(name) == m_bindings.end()) {
+      m_bindings[name] = std::unique_ptr<binding_stats>(new binding_stats());
+    }
+  }
+
+  void message(size_t size, stats_clock::time_point start,
+               const std::string &name) {
+    auto end = now();
+    m_messages.fetch_add(1, std::memory_order_relaxed);
+    m_message_bytes.fetch_add(size, std::memory_order_relaxed);
+    m_message_latency.record(elapsed_ns(start, end));
+    trace("on_message", name, start, end);
+  }
+
+  void call(const std::string &seq, const std::string &name,
+            stats_clock::time_point start) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_bindings.find(name);
+    if (it == m_bindings.end()) {
+      return;
+    }
+    it->second->calls.fetch_add(1, std::memory_order_relaxed);
+    m_pending[seq] = pending_t{name, it->second.get(), start};
+  }
+
+  void resolve(const std::string &seq, int status) {
+    auto end = now();
+    m_resolves.fetch_add(1, std::memory_order_relaxed);
+    pending_t p;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto it = m_pending.find(seq);
+      if (it == m_pending.end()) {
+        return;
+      }
+      p = it->second;
+      m_pending.erase(it);
+    }
+    if (status != 0) {
+      p.stats->errors.fetch_add(1, std::memory_order_relaxed);
+    }
+    p.stats->latency.record(elapsed_ns(p.start, end));
+    trace("rpc", p.name, p.start, end);
+  }
+
+  stats_clock::time_point dispatch() {
+    m_dispatched.fetch_add(1, std::memory_order_relaxed);
+    m_dispatch_depth.fetch_add(1, std::memory_order_relaxed);
+    return now();
+  }
+
+  void dispatched(stats_clock::time_point queued,
+                  stats_clock::time_point start) {
+    m_dispatch_depth.fetch_sub(1, std::memory_order_relaxed);
+    m_dispatch_wait.record(elapsed_ns(queued, start));
+    trace("dispatch", "", start, now());
+  }
+
+  void eval(size_t size, stats_clock::time_point start) {
+    m_evals.fetch_add(1, std::memory_order_relaxed);
+    m_eval_bytes.fetch_add(size, std::memory_order_relaxed);
+    uint64_t max = m_eval_max_bytes.load(std::memory_order_relaxed);
+    while (size > max && !m_eval_max_bytes.compare_exchange_weak(
+                             max, size, std::memory_order_relaxed)) {
+    }
+    trace("eval", "", start, now());
+  }
+
+  void navigate(stats_clock::time_point start) {
+    m_navigations.fetch_add(1, std::memory_order_relaxed);
+    trace("navigate", "", start, now());
+  }
+
+  // RPC sequence numbers restart with every page, so once a new page has
+  // committed, calls left unresolved by the previous one are dropped rather
+  // than matched to new ones.
+  void page() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.clear();
+  }
+
+  void set_trace(bool enable) {
+    std::lock_guard<std::mutex> lock(m_trace_mutex);
+    if (enable) {
+      m_trace_events.clear();
+      m_trace_next = 0;
+    }
+    m_tracing.store(enable);
+  }
+
+  std::string to_json() {
+    std::string bindings;
+    size_t backlog;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      backlog = m_pending.size();
+      for (auto &b : m_bindings) {
+        if (!bindings.empty()) {
+          bindings += ",";
+        }
+        bindings += json_escape(b.first) + ":{\"calls\":" +
+                    std::to_string(b.second->calls.load()) +
+                    ",\"errors\":" + std::to_string(b.second->errors.load()) +
+                    ",\"latency\":" + b.second->latency.to_json() + "}";
+      }
+    }
+    return "{\"enabled\":true"
+           ",\"messages\":" +
+           std::to_string(m_messages.load()) +
+           ",\"message_bytes\":" + std::to_string(m_message_bytes.load()) +
+           ",\"message_latency\":" + m_message_latency.to_json() +
+           ",\"dispatched\":" + std::to_string(m_dispatched.load()) +
+           ",\"dispatch_depth\":" + std::to_string(m_dispatch_depth.load()) +
+           ",\"dispatch_wait\":" + m_dispatch_wait.to_json() +
+           ",\"evals\":" + std::to_string(m_evals.load()) +
+           ",\"eval_bytes\":" + std::to_string(m_eval_bytes.load()) +
+           ",\"eval_max_bytes\":" + std::to_string(m_eval_max_bytes.load()) +
+           ",\"navigations\":" + std::to_string(m_navigations.load()) +
+           ",\"resolves\":" + std::to_string(m_resolves.load()) +
+           ",\"resolve_backlog\":" + std::to_string(backlog) +
+           ",\"bindings\":{" + bindings + "}}";
+  }
+
+  std::string trace_json() {
+    std::lock_guard<std::mutex> lock(m_trace_mutex);
+    std::string events;
+    size_t n = m_trace_events.size();
+    for (size_t i = 0; i < n; i++) {
+      auto &e = m_trace_events[(m_trace_next + i) % n];
+      char buf[160];
+      snprintf(buf, sizeof(buf),
+               "{\"name\":\"%s\",\"cat\":\"go_webkit\",\"ph\":\"X\","
+               "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%llu",
+               e.name, (double)e.ts_ns / 1000.0, (double)e.dur_ns / 1000.0,
+               (unsigned long long)e.tid);
+      if (!events.empty()) {
+        events += ",";
+      }
+      events += buf;
+      if (!e.arg.empty()) {
+        events += ",\"args\":{\"binding\":" + json_escape(e.arg) + "}";
+      }
+      events += "}";
+    }
+    return "{\"traceEvents\":[" + events + "],\"displayTimeUnit\":\"ns\"}";
+  }
+
+private:
+  static const size_t trace_capacity = 1 << 16;
+
+  struct binding_stats {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> errors{0};
+    histogram latency;
+  };
+  struct pending_t {
+    std::string name;
+    binding_stats *stats;
+    stats_clock::time_point start;
+  };
+  struct trace_event_t {
+    const char *name;
+    std::string arg;
+    uint64_t ts_ns;
+    uint64_t dur_ns;
+    uint64_t tid;
+  };
+
+  void trace(const char *name, const std::string &arg,
+             stats_clock::time_point start, stats_clock::time_point end) {
+    if (!m_tracing.load(std::memory_order_relaxed)) {
+      return;
+    }
+    trace_event_t e{name, arg, elapsed_ns(m_epoch, start),
+                    elapsed_ns(start, end),
+                    (uint64_t)std::hash<std::thread::id>()(
+                        std::this_thread::get_id()) &
+                        0xffffffff};
+    std::lock_guard<std::mutex> lock(m_trace_mutex);
+    if (m_trace_events.size() < trace_capacity) {
+      m_trace_events.push_back(e);
+    } else {
+      m_trace_events[m_trace_next] = e;
+      m_trace_next = (m_trace_next + 1) % trace_capacity;
+    }
+  }
+
+  stats_clock::time_point m_epoch;
+  std::atomic<uint64_t> m_messages{0};
+  std::atomic<uint64_t> m_message_bytes{0};
+  std::atomic<uint64_t> m_dispatched{0};
+  std::atomic<int64_t> m_dispatch_depth{0};
+  std::atomic<uint64_t> m_evals{0};
+  std::atomic<uint64_t> m_eval_bytes{0};
+  std::atomic<uint64_t> m_eval_max_bytes{0};
+  std::atomic<uint64_t> m_navigations{0};
+  std::atomic<uint64_t> m_resolves{0};
+  histogram m_message_latency;
+  histogram m_dispatch_wait;
+
+  std::mutex m_mutex;
+  std::map<std::string, std::unique_ptr<binding_stats>> m_bindings;
+  std::map<std::string, pending_t> m_pending;
+
+  std::atomic<bool> m_tracing{false};
+  std::mutex m_trace_mutex;
+  std::vector<trace_event_t> m_trace_events;
+  size_t m_trace_next = 0;
+};
+
+#else
+
+// Instrumentation compiled out with GO_WEBKIT_NO_STATS; every hook is empty
+// so the hot paths carry no extra work.
+class stats {
+public:
+  static stats_clock::time_point now() { return stats_clock::time_point(); }
+  void bind(const std::string &) {}
+  void message(size_t, stats_clock::time_point, const std::string &) {}
+  void call(const std::string &, const std::string &, stats_clock::time_point) {}
+  void resolve(const std::string &, int) {}
+  void navigate(stats_clock::time_point) {}
+  void page() {}
+  void set_trace(bool) {}
+  std::string to_json() { return "{\"enabled\":false}"; }
+  std::string trace_json() {
+    return "{\"traceEvents\":[],\"displayTimeUnit\":\"ns\"}";
+  }
+};
+
+#endif /* GO_WEBKIT_NO_STATS */
+
 } // namespace go_webkit
 
 //
@@ -467,6 +863,15 @@ public:
     init("window.external={invoke:function(s){window.webkit.messageHandlers."
          "external.postMessage(s);}}");
 
+    g_signal_connect(G_OBJECT(m_webview), "load-changed",
+                     G_CALLBACK(+[](WebKitWebView *, WebKitLoadEvent event,
+                                    gpointer arg) {
+                       if (event == WEBKIT_LOAD_COMMITTED) {
+                         static_cast<gtk_webkit_engine *>(arg)->on_commit();
+                       }
+                     }),
+                     this);
+
     gtk_container_add(GTK_CONTAINER(m_window), GTK_WIDGET(m_webview));
     gtk_widget_grab_focus(GTK_WIDGET(m_webview));
 
@@ -489,7 +894,7 @@ public:
                       (*static_cast<dispatch_fn_t *>(f))();
                       return G_SOURCE_REMOVE;
                     }),
-                    new std::function<void()>(f),
+                    new std::function<void()>(std::move(f)),
                     [](void *f) { delete static_cast<dispatch_fn_t *>(f); });
   }
 
@@ -534,6 +939,7 @@ public:
 
 private:
   virtual void on_message(const std::string msg) = 0;
+  virtual void on_commit() {}
   GtkWidget *m_window;
   GtkWidget *m_webview;
 };
@@ -550,19 +956,34 @@ public:
       : browser_engine(debug, wnd) {}
 
   void navigate(const std::string url) {
+    auto start = m_stats.now();
     if (url == "") {
       browser_engine::navigate("data:text/html," +
                                url_encode("<html><body>Hello</body></html>"));
-      return;
-    }
-    std::string html = html_from_uri(url);
-    if (html != "") {
-      browser_engine::navigate("data:text/html," + url_encode(html));
     } else {
-      browser_engine::navigate(url);
+      std::string html = html_from_uri(url);
+      if (html != "") {
+        browser_engine::navigate("data:text/html," + url_encode(html));
+      } else {
+        browser_engine::navigate(url);
+      }
     }
+    m_stats.navigate(start);
   }
 
+#ifndef GO_WEBKIT_NO_STATS
+  void dispatch(std::function<void()> f) {
+    browser_engine::dispatch(
+        timed_fn{std::move(f), &m_stats, m_stats.dispatch()});
+  }
+
+  void eval(const std::string js) {
+    auto start = m_stats.now();
+    browser_engine::eval(js);
+    m_stats.eval(js.size(), start);
+  }
+#endif /* GO_WEBKIT_NO_STATS */
+
   using binding_t = std::function<void(std::string, std::string, void *)>;
   using binding_ctx_t = std::pair<binding_t *, void *>;
 
@@ -600,6 +1021,7 @@ public:
     })())";
     init(js);
     bindings[name] = new binding_ctx_t(new binding_t(f), arg);
+    m_stats.bind(name);
   }
 
   void resolve(const std::string seq, int status, const std::string result) {
@@ -611,21 +1033,46 @@ public:
         eval("window._rpc[" + seq + "].reject(" + result + "); window._rpc[" +
              seq + "] = undefined");
       }
+      m_stats.resolve(seq, status);
     });
   }
 
+  std::string stats_json() { return m_stats.to_json(); }
+  std::string trace_json() { return m_stats.trace_json(); }
+  void set_trace(bool enable) { m_stats.set_trace(enable); }
+
 private:
   void on_message(const std::string msg) {
+    auto start = m_stats.now();
     auto seq = json_parse(msg, "id", 0);
     auto name = json_parse(msg, "method", 0);
     auto args = json_parse(msg, "params", 0);
-    if (bindings.find(name) == bindings.end()) {
-      return;
+    if (bindings.find(name) != bindings.end()) {
+      m_stats.call(seq, name, start);
+      auto fn = bindings[name];
+      (*fn->first)(seq, args, fn->second);
     }
-    auto fn = bindings[name];
-    (*fn->first)(seq, args, fn->second);
+    m_stats.message(msg.size(), start, name);
   }
+  void on_commit() { m_stats.page(); }
+
+#ifndef GO_WEBKIT_NO_STATS
+  // Records the queue wait of a dispatched function. A functor rather than a
+  // lambda so that f is moved in, not copied.
+  struct timed_fn {
+    std::function<void()> f;
+    stats *s;
+    stats_clock::time_point queued;
+    void operator()() {
+      auto start = s->now();
+      f();
+      s->dispatched(queued, start);
+    }
+  };
+#endif /* GO_WEBKIT_NO_STATS */
+
   std::map<std::string, binding_ctx_t *> bindings;
+  stats m_stats;
 };
 } // namespace go_webkit
 
@@ -692,6 +1139,18 @@ GO_WEBKIT_API void go_webkit_return(go_webkit_t w, const char *seq, int status,
   static_cast<go_webkit::go_webkit *>(w)->resolve(seq, status, result);
 }
 
+GO_WEBKIT_API char *go_webkit_stats(go_webkit_t w) {
+  return strdup(static_cast<go_webkit::go_webkit *>(w)->stats_json().c_str());
+}
+
+GO_WEBKIT_API void go_webkit_trace(go_webkit_t w, int enable) {
+  static_cast<go_webkit::go_webkit *>(w)->set_trace(enable != 0);
+}
+
+GO_WEBKIT_API char *go_webkit_trace_json(go_webkit_t w) {
+  return strdup(static_cast<go_webkit::go_webkit *>(w)->trace_json().c_str());
+}
+
 #endif /* GO_WEBKIT_HEADER */
 
 #endif /* GO_WEBKIT_H */
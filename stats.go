@@ -0,0 +1,135 @@
+package webkit
+
+import (
+	"fmt"
+	"io"
+	"sort"
+	"strings"
+)
+
+// Histogram is a latency distribution in nanoseconds. Percentiles are taken
+// from log-linear buckets and are accurate to within 25%.
+type Histogram struct {
+	Count  uint64 `json:"count"`
+	SumNs  uint64 `json:"sum_ns"`
+	MaxNs  uint64 `json:"max_ns"`
+	P50Ns  uint64 `json:"p50_ns"`
+	P90Ns  uint64 `json:"p90_ns"`
+	P99Ns  uint64 `json:"p99_ns"`
+	P999Ns uint64 `json:"p999_ns"`
+}
+
+// BindingStats describes the calls made to a single bound function. Latency
+// is measured on the main thread from the message arriving from JavaScript
+// until the script resolving its promise has been submitted.
+type BindingStats struct {
+	Calls   uint64    `json:"calls"`
+	Errors  uint64    `json:"errors"`
+	Latency Histogram `json:"latency"`
+}
+
+// Stats is a snapshot of the bridge counters. Enabled is false if the library
+// was compiled with GO_WEBKIT_NO_STATS, in which case every other field is zero.
+type Stats struct {
+	Enabled        bool                    `json:"enabled"`
+	Messages       uint64                  `json:"messages"`
+	MessageBytes   uint64                  `json:"message_bytes"`
+	MessageLatency Histogram               `json:"message_latency"`
+	Dispatched     uint64                  `json:"dispatched"`
+	DispatchDepth  int64                   `json:"dispatch_depth"`
+	DispatchWait   Histogram               `json:"dispatch_wait"`
+	Evals          uint64                  `json:"evals"`
+	EvalBytes      uint64                  `json:"eval_bytes"`
+	EvalMaxBytes   uint64                  `json:"eval_max_bytes"`
+	Navigations    uint64                  `json:"navigations"`
+	Resolves       uint64                  `json:"resolves"`
+	ResolveBacklog uint64                  `json:"resolve_backlog"`
+	Bindings       map[string]BindingStats `json:"bindings"`
+}
+
+// WritePrometheus writes the snapshot in the Prometheus text exposition
+// format. Latencies are exported as summaries in seconds.
+func (s Stats) WritePrometheus(w io.Writer) error {
+	b := &strings.Builder{}
+	metric := func(name, kind, help string) {
+		fmt.Fprintf(b, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, kind)
+	}
+	value := func(name, labels string, v interface{}) {
+		if labels != "" {
+			labels = "{" + labels + "}"
+		}
+		fmt.Fprintf(b, "%s%s %v\n", name, labels, v)
+	}
+	summary := func(name, labels string, h Histogram) {
+		sep := ""
+		if labels != "" {
+			sep = ","
+		}
+		for _, q := range []struct {
+			q string
+			v uint64
+		}{{"0.5", h.P50Ns}, {"0.9", h.P90Ns}, {"0.99", h.P99Ns}, {"0.999", h.P999Ns}} {
+			value(name, labels+sep+`quantile="`+q.q+`"`, seconds(q.v))
+		}
+		value(name+"_sum", labels, seconds(h.SumNs))
+		value(name+"_count", labels, h.Count)
+	}
+
+	metric("go_webkit_messages_total", "counter", "Messages received from JavaScript.")
+	value("go_webkit_messages_total", "", s.Messages)
+	metric("go_webkit_message_bytes_total", "counter", "Bytes of messages received from JavaScript.")
+	value("go_webkit_message_bytes_total", "", s.MessageBytes)
+	metric("go_webkit_message_seconds", "summary", "Time spent handling a message.")
+	summary("go_webkit_message_seconds", "", s.MessageLatency)
+	metric("go_webkit_dispatch_total", "counter", "Functions posted to the main thread.")
+	value("go_webkit_dispatch_total", "", s.Dispatched)
+	metric("go_webkit_dispatch_queue_depth", "gauge", "Posted functions not yet run.")
+	value("go_webkit_dispatch_queue_depth", "", s.DispatchDepth)
+	metric("go_webkit_dispatch_wait_seconds", "summary", "Time a posted function waits before running.")
+	summary("go_webkit_dispatch_wait_seconds", "", s.DispatchWait)
+	metric("go_webkit_evals_total", "counter", "Scripts evaluated.")
+	value("go_webkit_evals_total", "", s.Evals)
+	metric("go_webkit_eval_bytes_total", "counter", "Bytes of scripts evaluated.")
+	value("go_webkit_eval_bytes_total", "", s.EvalBytes)
+	metric("go_webkit_eval_max_bytes", "gauge", "Largest script evaluated.")
+	value("go_webkit_eval_max_bytes", "", s.EvalMaxBytes)
+	metric("go_webkit_navigations_total", "counter", "Navigations started.")
+	value("go_webkit_navigations_total", "", s.Navigations)
+	metric("go_webkit_resolves_total", "counter", "Binding results returned to JavaScript.")
+	value("go_webkit_resolves_total", "", s.Resolves)
+	metric("go_webkit_resolve_backlog", "gauge", "Binding calls waiting for a result.")
+	value("go_webkit_resolve_backlog", "", s.ResolveBacklog)
+
+	names := []string{}
+	for name := range s.Bindings {
+		names = append(names, name)
+	}
+	sort.Strings(names)
+	metric("go_webkit_binding_calls_total", "counter", "Calls made to a bound function.")
+	for _, name := range names {
+		value("go_webkit_binding_calls_total", bindingLabel(name), s.Bindings[name].Calls)
+	}
+	metric("go_webkit_binding_errors_total", "counter", "Calls to a bound function that returned an error.")
+	for _, name := range names {
+		value("go_webkit_binding_errors_total", bindingLabel(name), s.Bindings[name].Errors)
+	}
+	metric("go_webkit_binding_seconds", "summary", "Time from a call to a bound function until the script resolving it is submitted.")
+	for _, name := range names {
+		summary("go_webkit_binding_seconds", bindingLabel(name), s.Bindings[name].Latency)
+	}
+
+	_, err := io.WriteString(w, b.String())
+	return err
+}
+
+// labelEscaper applies the only escapes the exposition format accepts in label
+// values.
+var labelEscaper = strings.NewReplacer(`\`, `\\`, `"`, `\"`, "\n", `\n`)
+
+func bindingLabel(name string) string {
+	return `binding="` + labelEscaper.Replace(name) + `"`
+}
+
+func seconds(ns uint64) float64 {
+	return float64(ns) / 1e9
+}
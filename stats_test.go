@@ -0,0 +1,79 @@
+package webkit
+
+import (
+	"encoding/json"
+	"strings"
+	"testing"
+)
+
+// A snapshot in the shape returned by go_webkit_stats.
+const statsJSON = `{"enabled":true,"messages":3,"message_bytes":110,
+"message_latency":{"count":3,"sum_ns":24000,"max_ns":18000,"p50_ns":4000,"p90_ns":18000,"p99_ns":18000,"p999_ns":18000},
+"dispatched":2,"dispatch_depth":1,
+"dispatch_wait":{"count":1,"sum_ns":50000,"max_ns":50000,"p50_ns":50000,"p90_ns":50000,"p99_ns":50000,"p999_ns":50000},
+"evals":1,"eval_bytes":55,"eval_max_bytes":55,"navigations":1,"resolves":1,"resolve_backlog":1,
+"bindings":{"echo":{"calls":2,"errors":1,"latency":{"count":1,"sum_ns":1500000,"max_ns":1500000,"p50_ns":1000000,"p90_ns":1500000,"p99_ns":1500000,"p999_ns":1500000}},
+"a\"b\\c\nd\te":{"calls":1,"errors":0,"latency":{"count":0,"sum_ns":0,"max_ns":0,"p50_ns":0,"p90_ns":0,"p99_ns":0,"p999_ns":0}}}}`
+
+func TestStatsDecode(t *testing.T) {
+	s := Stats{}
+	if err := json.Unmarshal([]byte(statsJSON), &s); err != nil {
+		t.Fatal(err)
+	}
+	if !s.Enabled || s.Messages != 3 || s.DispatchDepth != 1 || s.ResolveBacklog != 1 {
+		t.Fatalf("unexpected counters: %+v", s)
+	}
+	echo, ok := s.Bindings["echo"]
+	if !ok || echo.Calls != 2 || echo.Errors != 1 || echo.Latency.P50Ns != 1000000 {
+		t.Fatalf("unexpected echo binding: %+v", echo)
+	}
+	if _, ok := s.Bindings["a\"b\\c\nd\te"]; !ok {
+		t.Fatalf("escaped binding name not decoded: %v", s.Bindings)
+	}
+}
+
+func TestStatsWritePrometheus(t *testing.T) {
+	s := Stats{}
+	if err := json.Unmarshal([]byte(statsJSON), &s); err != nil {
+		t.Fatal(err)
+	}
+	b := &strings.Builder{}
+	if err := s.WritePrometheus(b); err != nil {
+		t.Fatal(err)
+	}
+	out := b.String()
+	for _, line := range []string{
+		"# HELP go_webkit_messages_total Messages received from JavaScript.",
+		"# TYPE go_webkit_messages_total counter",
+		"go_webkit_messages_total 3",
+		"# TYPE go_webkit_dispatch_queue_depth gauge",
+		"go_webkit_dispatch_queue_depth 1",
+		"# TYPE go_webkit_message_seconds summary",
+		`go_webkit_message_seconds{quantile="0.5"} 4e-06`,
+		`go_webkit_message_seconds{quantile="0.999"} 1.8e-05`,
+		"go_webkit_message_seconds_sum 2.4e-05",
+		"go_webkit_message_seconds_count 3",
+		"go_webkit_resolve_backlog 1",
+		`go_webkit_binding_calls_total{binding="echo"} 2`,
+		`go_webkit_binding_errors_total{binding="echo"} 1`,
+		`go_webkit_binding_seconds{binding="echo",quantile="0.5"} 0.001`,
+		`go_webkit_binding_seconds{binding="echo",quantile="0.99"} 0.0015`,
+		`go_webkit_binding_seconds_sum{binding="echo"} 0.0015`,
+		`go_webkit_binding_seconds_count{binding="echo"} 1`,
+		"go_webkit_binding_calls_total{binding=\"a\\\"b\\\\c\\nd\te\"} 1",
+	} {
+		if !strings.Contains(out, line+"\n") {
+			t.Errorf("missing line %q in:\n%s", line, out)
+		}
+	}
+	// Every HELP line is followed by its TYPE line.
+	lines := strings.Split(out, "\n")
+	for i, line := range lines {
+		if strings.HasPrefix(line, "# HELP ") {
+			name := strings.Fields(line)[2]
+			if i+1 >= len(lines) || !strings.HasPrefix(lines[i+1], "# TYPE "+name+" ") {
+				t.Errorf("HELP for %s is not followed by its TYPE", name)
+			}
+		}
+	}
+}